@@ -0,0 +1,158 @@
+#ifndef __TB_BakedCache_h__
+#define __TB_BakedCache_h__
+
+#include <UT/UT_BoundingBox.h>
+#include <SYS/SYS_Types.h>
+
+#include "TB_SampleData.h"
+
+/// Baked interpolation caches (.tbc). Matching, gathering and weights
+/// are the same on every render of a sequence, so tb_bake does them
+/// once: a .tbc holds id-matched channels of all samples in the
+/// reference point order, ready to be blended straight from a memory
+/// mapping (pages load lazily, on first touch).
+///
+/// Layout, every section starts at a TB_BAKE_ALIGN boundary:
+///     TB_BakeHeader
+///     nodes     float[entries]          sample times
+///     weights   float[entries]          barycentric weights of nodes (order)
+///     layout    TB_BakeAttrib[attribs]  channels past P
+///     ids       int32[points]           reference ids (if hasids)
+///     index     int32[points] x 2       ids sorted, then their points
+///     bounds    float[chunks * 6]       motion bounds of point chunks
+///     data      float[entries * channels * stride]
+/// Channel c of sample g starts at data + (g*channels + c)*stride,
+/// stride being points rounded up to TB_BAKE_ALIGN bytes.
+
+namespace TimeBlender
+{
+#define TB_BAKE_MAGIC    "TBCACHE"
+#define TB_BAKE_VERSION  3
+#define TB_BAKE_ALIGN    64
+#define TB_BAKE_NAMESIZE 64
+#define TB_BAKE_PATHSIZE 1024
+
+struct TB_BakeHeader
+{
+    char   magic[8];
+    int32  version;
+    int32  entries;
+    int32  points;
+    int32  channels;
+    int32  attribs;
+    int32  reference;
+    int32  hasids;
+    int32  explicittimes;
+    int32  chunksize;
+    int32  chunks;
+    int32  order;
+    int32  pad;
+    int64  stride;
+    /// Section offsets in bytes:
+    int64  nodes;
+    int64  weights;
+    int64  layout;
+    int64  ids;
+    int64  index;
+    int64  bounds;
+    int64  data;
+    int64  size;
+    /// Modification time and size of source when baked.
+    int64  sourcemtime;
+    int64  sourcesize;
+    /// File the reference topology comes from (may be gone).
+    char   source[TB_BAKE_PATHSIZE];
+};
+
+struct TB_BakeAttrib
+{
+    char   name[TB_BAKE_NAMESIZE];
+    int32  size;
+    int32  offset;
+    int32  normal;
+    int32  pad;
+};
+
+class TB_BakedCache
+{
+public:
+    TB_BakedCache();
+    ~TB_BakedCache() { close(); }
+
+    /// Map a cache, fails on anything but a complete cache of this version.
+    int  open(const char *filename);
+    void close();
+    bool isOpen() const { return myHeader != NULL; }
+
+    /// Has filename .tbc extension.
+    static bool isBakedFile(const char *filename);
+
+    /// Bake id-matched channels of source, nodes[source.entries()] are
+    /// times of samples (NULL: normalized, see GeoInterpolant::getNodeTime),
+    /// reffile is the file of reference sample (index reference), it has
+    /// to exist and its path has to be shorter than TB_BAKE_PATHSIZE
+    /// (NULL: none, the cache has no topology of its own). 
+    /// Writes a temporary file (created exclusively under a unique 
+    /// name next to filename) renamed when complete, so readers never 
+    /// see a partial cache, and concurrent writers never share one.
+    /// The cache gets permissions mode. Weights are of order (see 
+    /// GeoInterpolant::setOrder()).
+    static int write(const char *filename, const TB_SampleSource &source,
+                     const float *nodes, int order, int reference, const char *reffile,
+                     int chunksize = 4096, int nthreads = 0, int mode = 0644);
+
+    /// Number of samples, points and channels per sample.
+    int   entries()        const { return myHeader->entries; }
+    int   getNumPoints()   const { return myHeader->points; }
+    int   getNumChannels() const { return myHeader->channels; }
+    int64 getStride()      const { return myHeader->stride; }
+    /// Bytes of the mapped file.
+    int64 getSize()        const { return mySize; }
+    const TB_ChannelLayout & getLayout() const { return myLayout; }
+
+    /// Sample times, explicit unless baked without them.
+    const float * getNodes()   const { return (const float *)(myMap + myHeader->nodes); }
+    bool  hasExplicitTimes()   const { return myHeader->explicittimes != 0; }
+    /// Barycentric weights of nodes, of getOrder().
+    const float * getWeights() const { return (const float *)(myMap + myHeader->weights); }
+    int   getOrder()           const { return myHeader->order; }
+
+    /// All channel blocks, and channel c of sample g.
+    const float * getData() const { return (const float *)(myMap + myHeader->data); }
+    const float * getChannel(int g, int c) const
+    {
+        return getData() + ((int64)g * getNumChannels() + c) * getStride();
+    }
+
+    /// Reference ids, NULL if baked without.
+    const int * getIds() const
+    {
+        return myHeader->hasids ? (const int *)(myMap + myHeader->ids) : NULL;
+    }
+    /// Point of an id, TB_MISSING_ID if absent.
+    int find(int id) const;
+
+    /// Motion bounds (unpadded) of points [k*chunksize, (k+1)*chunksize).
+    int  getNumChunks() const { return myHeader->chunks; }
+    int  getChunkSize() const { return myHeader->chunksize; }
+    void getChunkBounds(int k, UT_BoundingBox &box) const;
+    /// ... and of all of them.
+    void getBounds(UT_BoundingBox &box) const;
+
+    /// Reference detail the cache was baked from, and its sample.
+    const char * getSource()    const { return myHeader->source; }
+    int          getReference() const { return myHeader->reference; }
+    /// Source is still the file baked from (same mtime and size).
+    bool         isSourceCurrent() const;
+
+    /// Mapped bytes.
+    int64 getMemoryUsage() const { return mySize; }
+
+private:
+    const char          *myMap;
+    int64                mySize;
+    const TB_BakeHeader *myHeader;
+    TB_ChannelLayout     myLayout;
+};
+} // End of Timeblender namespace
+#endif
@@ -0,0 +1,83 @@
+#ifndef __TB_Buckets_h__
+#define __TB_Buckets_h__
+
+#include <string>
+#include <vector>
+#include <GU/GU_Detail.h>
+#include <UT/UT_BoundingBox.h>
+#include <UT/UT_RefArray.h>
+#include <SYS/SYS_Types.h>
+
+#include "TB_SampleData.h"
+
+/// Spatial partition of reference points into buckets rendered by 
+/// separate (child) procedurals. Points are split by median cuts 
+/// along the longest axis of their motion centers, a kd-tree whose 
+/// leaves are the buckets. Bucket bounds enclose all samples of their 
+/// points, padded for interpolant overshoot.
+
+namespace TimeBlender
+{
+/// Points order[start..end) of a partition, bounds of their motion.
+class TB_Bucket
+{
+public:
+    int             start;
+    int             end;
+    UT_BoundingBox  box;
+};
+
+/// Splits points of source into buckets of at most maxpoints. order[] 
+/// (of source.getNumPoints()) gets point numbers grouped by bucket, 
+/// buckets are appended in order. Each point's motion bounds are 
+/// widened by pad times their extent. Returns number of buckets.
+int TBbuildBuckets(const TB_SampleSource &source, int maxpoints, float pad,
+                   UT_RefArray<TB_Bucket> &buckets, int *order, int nthreads = 0);
+
+/// Int or float tuple point attribute, values of all points.
+struct TB_PointAttrib
+{
+    std::string         name;
+    GB_AttribType       type;
+    int                 size;
+    std::vector<float>  floats;
+    std::vector<int>    ints;
+};
+
+/*********************************************************
+ Point attributes of a reference detail in bucket order, 
+ so the detail itself can be freed while buckets wait for
+ rays. P isn't kept, buckets interpolate it anyway. Each 
+ bucket rebuilds its slice of points (in a particle system,
+ if the reference had one). Only int and float point 
+ attributes are kept, details with anything else aren't
+ bucketed (see canBucket()).
+ ********************************************************/
+
+class TB_BucketPoints
+{
+public:
+    TB_BucketPoints() : myPoints(0), myParticles(false) {};
+    
+    /// Points without primitives, or a single particle system of all 
+    /// points (POP caches), with nothing buckets would lose: int and 
+    /// float point attributes only (no strings, ie. shop_materialpath),
+    /// no primitive, vertex or detail attributes (but varmap)?
+    static bool canBucket(const GU_Detail *gdp);
+    
+    /// Keep attributes of points order[n] of gdp.
+    void extract(const GU_Detail *gdp, const int *order, int n, int nthreads = 0);
+    
+    /// Append points [start, end) to gdp, with their attributes.
+    void build(GU_Detail *gdp, int start, int end) const;
+    
+    int64 getMemoryUsage() const;
+    
+private:
+    std::vector<TB_PointAttrib> myAttribs;
+    int                         myPoints;
+    bool                        myParticles;
+};
+
+} // End of Timeblender namespace
+#endif
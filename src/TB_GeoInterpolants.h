@@ -6,10 +6,13 @@
 #include <GEO/GEO_Point.h>
 #include <GU/GU_Detail.h>
 #include <GB/GB_Macros.h>
+#include <SYS/SYS_Types.h>
 #include <UT/UT_Spline.h>
 #include <UT/UT_Color.h>
 
 #include "TB_PointMatch.h"
+#include "TB_SampleData.h"
+#include "TB_Parallel.h"
 
 namespace TimeBlender
 {
@@ -17,13 +20,15 @@ namespace TimeBlender
 typedef enum {
 
 	TB_INTER_NONE,   /* None */
-	TB_INTER_LINEAR, /*Native HDK UT_Splines*/				 
+	TB_INTER_LINEAR, /*Coefficient vectors (BRInterpolant)*/				 
 	TB_INTER_CATMULLROM,
-	TB_INTER_CUBIC,
+	TB_INTER_CUBIC,  /*Native HDK UT_Splines (monotone cubic)*/
 	TB_INTER_BARYCENTRIC,  /*Barycentric Rational Interpolation*/          
 
 } TB_INTER_TYPES;
 
+class TB_BakedCache;
+
 /// Utility functions.
 inline void fit(const double x, 
                 const fpreal a, 
@@ -44,21 +49,26 @@ inline void debug(const char * info)
 class GeoInterpolant
 {
 public:
+	virtual ~GeoInterpolant() {};
+
 	/// Call it in a default constractor.
 	virtual int initialize(int size, int typem) = 0;
 	
-	/// Build interpolant with plain GU_Details:
-    virtual void build(UT_PtrArray<GU_Detail*> gdps, int current_frame) = 0;
-    
-    /// Build interpolant with Point Match: red/black tree 
-    /// (std::map) for point-point by id matching
-    virtual void build(UT_PtrArray<TB_PointMatch *>, const GU_Detail *) = 0;    
+	/// Build interpolant from compact samples, matched by point number
+	/// or by id (see TB_SampleSource):
+    virtual void build(const TB_SampleSource &source) = 0;
        
-	/// This computes interpolattion and modifies GU_Detail's 'P' accoring to it.
+	/// This computes interpolattion and modifies GU_Detail's 'P' (and 
+	/// attributes of the layout the interpolant was built with) accoring to it.
 	virtual void interpolate(const float, GU_Detail  * const) const = 0;
+	
+	/// First derivative of P at u (per unit of u) times scale, written 
+	/// into float vector point attribute name of gdp (added if missing).
+	virtual void differentiate(const float u, const float scale, 
+	                           GU_Detail * const gdp, const char *name = "v") const = 0;
 
-	/// Avarage mem usage:
-	virtual int getMemoryUsage() const = 0;
+	/// Avarage mem usage (64bit, big caches easily exceed 2GB):
+	virtual int64 getMemoryUsage() const = 0;
 	
 	/// Utilities:
 	virtual int init_arrays(float *a, float *b,
@@ -67,6 +77,59 @@ public:
 	virtual int getitype() const = 0;
 	virtual bool isValid() const = 0;
 	virtual bool isAlloc() const = 0;
+	
+	/// Explicit times of samples (ascending, same units as u passed to 
+	/// interpolate()), set before build(). Without them nodes are 
+	/// normalized, see getNodeTime().
+	void setNodes(const float *nodes, int n) { myNodes.assign(nodes, nodes+n); };
+	bool hasNodes() const { return !myNodes.empty(); };
+	
+	/// Normalized time of a sample node: barycentric interpolants place
+	/// entries nodes at i/entries, splines span them over 0-1.
+	static float getNodeTime(int itype, int i, int entries)
+	{
+	    if (itype == TB_INTER_BARYCENTRIC) 
+	        return 1.0f*i/entries;
+	    return entries > 1 ? 1.0f*i/(entries-1) : 0.0f;
+	};
+	
+	/// How far an interpolant may leave the hull of its samples, as a 
+	/// fraction of samples' extent, evaluated at nu times u. Interpolants
+	/// are affine combinations f(u) = sum(lambda[i]*f[i]), so with
+	/// L = max(sum(|lambda[i]|)), overshoot is bounded by (L-1)/2.
+	/// nodes are explicit sample times (if any).
+	static float getOvershoot(int itype, int entries, const float *u, int nu,
+	                          const float *nodes = NULL, int order = -1);
+	
+	/// Bound of |f'(u)| (per unit of u) as a fraction of samples' extent:
+	/// f'(u) = sum(dlambda[i]*f[i]) with sum(dlambda[i]) = 0, so it's 
+	/// within sum(|dlambda[i]|)/2 of the extent.
+	static float getDerivativeBound(int itype, int entries, float u,
+	                                const float *nodes = NULL, int order = -1);
+	
+	/// Order of barycentric interpolants (< 0: entries-1, ie. a single 
+	/// polynomial through all samples). Low orders stay local: a sample
+	/// only bends the curve near itself, with no Runge oscillation over 
+	/// long windows. Set before build().
+	void setOrder(int d) { myOrder = d; };
+	static int clampOrder(int order, int entries)
+	{
+	    return order < 0 ? SYSmax(entries-1, 0) : SYSmin(order, SYSmax(entries-1, 0));
+	};
+	
+	/// Worker threads used by build() and interpolate() (<= 0: all cores).
+	void setThreads(int n) { myThreads = n; };
+	int  getThreads() const { return myThreads; };
+	
+	/// Channels interpolated, P and float point attributes.
+	const TB_ChannelLayout & getLayout() const { return myLayout; };
+
+protected:
+	GeoInterpolant() : myThreads(0), myOrder(-1) {};
+	int                 myThreads;
+	int                 myOrder;
+	TB_ChannelLayout    myLayout;
+	std::vector<float>  myNodes;
 
 private:
      ///  This probably shouldn't be in an abstract class?
@@ -100,13 +163,16 @@ public:
         delete [] idx;
         delete [] val;
         delete [] wei;
-        cout << "idx, val, wei deleted" << endl; 
     }
     
     int initialize(float *ii, float *x, int n, int d);
     
     float evaluate(float u) const;
     
+    /// Floater-Hormann weights for nodes ii[n] of order d, written to w[n].
+    /// Shared by TB_Bri and TB_BriTable.
+    static void computeWeights(const float *ii, int n, int d, float *w);
+    
     int isAlloc() {return alloc;}
     int getMemoryUsage() { return size * sizeof(float) * 3;}
     
@@ -124,7 +190,51 @@ private:
 };
 
 /****************************************************************
-/ The interpolator based on TB_Bri (see above).
+/ Node/weight table of TB_Bri. Since all points share the same
+/ nodes, weights are computed once per build, and the barycentric
+/ form collapses into a single vector of coefficients per 
+/ evaluation time: f(u) = sum(lambda[i] * f[i]). 
+*****************************************************************/
+
+class TB_BriTable
+{
+public:
+    TB_BriTable() : size(0), order(0), idx(NULL), wei(NULL) {};
+    ~TB_BriTable() 
+    {
+        delete [] idx;
+        delete [] wei;
+    }
+    
+    /// ii: nodes array; n: arrays' size; d: interpolation order <= n-1.
+    int initialize(const float *ii, int n, int d);
+    /// ... with weights already computed (ie. by a bake).
+    int initialize(const float *ii, const float *w, int n, int d);
+    
+    /// Fill lambda[n] with normalized coefficients for u.
+    void coefficients(float u, float *lambda) const;
+    /// ... and dlambda[n] with their derivatives (d/du).
+    void derivatives(float u, float *dlambda) const;
+    
+    int entries() const {return size;}
+    int getOrder() const {return order;}
+    int64 getMemoryUsage() const { return (int64)size * sizeof(float) * 2;}
+    
+private:
+    int size;
+    int order;
+    float *idx;
+    float *wei;
+};
+
+/****************************************************************
+/ The interpolator based on TB_Bri (see above). Channels (P and
+/ attributes) of all samples are stored in contiguous 
+/ structure-of-arrays blocks: 
+/ myData[(sample*myChannels + channel)*mySize + point], and blended 
+/ with a single SIMD kernel using coefficients from TB_Kernels.h 
+/ (TB_BriTable for many samples). Linear and Catmull-Rom bases are
+/ coefficient vectors too, so they are blended the same way.
 *****************************************************************/
 
 class BRInterpolant : public GeoInterpolant
@@ -133,65 +243,97 @@ public:
 	// Allocate vectors for storing interpolants structures
 	BRInterpolant(int size, int type = TB_INTER_BARYCENTRIC)
 	{
+		myData     = NULL;
+		myBlocks   = NULL;
+		myStride   = 0;
+		myEntries  = 0;
+		myChannels = 0;
+		myUniform  = false;
 		if(!initialize(size, type)) alloc = false;
 	};
 	
 	/// This requires initialization.
 	BRInterpolant()
 	{
-		valid = false;
-		alloc = false;
+		myData     = NULL;
+		myBlocks   = NULL;
+		myStride   = 0;
+		myEntries  = 0;
+		myChannels = 0;
+		myUniform  = false;
+		mySize     = 0;
+		valid     = false;
+		alloc     = false;
 	};
+	
+	~BRInterpolant() { delete [] myData; };
 
-	/// Allocate memory, set flags.
+	/// Set flags, positions are allocated on build.
 	int initialize(int size, int type)
 	{
-		interpolants.resize(3);
-		X.resize(size, NULL); Y.resize(size, NULL);
-		Z.resize(size, NULL);
-		interpolants.at(0) = &X;
-		interpolants.at(1) = &Y;
-		interpolants.at(2) = &Z;
-		
-		itype      = TB_INTER_BARYCENTRIC;
+		itype      = type;
 		mySize     = size;
 		valid      = false;
 		alloc      = true;
 		return 1;
 	};
     
-    /// Three main methods, builds with gdps, with red/black trees, 
+    /// Two main methods, builds with samples, 
     /// and interpolate positions in gdp:
-    void build(UT_PtrArray<GU_Detail*> gdps, int current_frame);        
-    void build(UT_PtrArray<TB_PointMatch *>, const GU_Detail *);
+    void build(const TB_SampleSource &source);
 	void interpolate(const float, GU_Detail * const) const;
+	void differentiate(const float u, const float scale, 
+	                   GU_Detail * const gdp, const char *name = "v") const;
+	
+	/// Blend straight from channel blocks of a mapped cache instead
+	/// of building (nothing is copied, cache has to outlive this),
+	/// its points start.. are points 0.. of this.
+	void attach(const TB_BakedCache &cache, int start = 0);
 	
-	/// The summ of ocupied memory:
-	int getMemoryUsage() const 
+	/// The summ of ocupied memory (mapped caches excluded):
+	int64 getMemoryUsage() const 
 	{ 
-	    int mem = 0;
-	    if (alloc) 
-	        mem = X.at(0)->getMemoryUsage() * mySize * 3;
-	    return mem;
+	    return (myData ? (int64)mySize * myEntries * myChannels * sizeof(float) : 0)
+	           + myTable.getMemoryUsage();
 	};
 	
 	/// Utilities:
-	int init_arrays(float *a, float *b, float *c,  float *d, int n);
+	int init_arrays(float *a, float *b, float *c, float *d, int n);
 	int getitype() const { return itype; };
 	bool isValid() const { return valid; };
 	bool isAlloc() const { return alloc; }; 
 
 private:
+	/// Allocate channels and set up nodes.
+	void allocate(int entries, int channels);
+	/// Set up nodes of entries samples, build node/weight table
+	/// (of weights if given, they have to be of myOrder).
+	void setupNodes(int entries, const float *weights = NULL);
+	
+	/// Coefficients at u of samples first..first+count, returns count.
+	int coefficients(float u, float *lambda, int &first) const;
+	/// ... and their derivatives.
+	int derivatives(float u, float *dlambda, int &first) const;
+
 	int  mySize;  
 	bool valid;
 	int  itype;
 	bool alloc;
+	int  myEntries;
+	int  myChannels;
 
-	/// 3 vectors of 1-dim interpolants.
-	vector <TB_Bri *> X;
-	vector <TB_Bri *> Y;
-	vector <TB_Bri *> Z;
-	vector <vector<TB_Bri  *> *>  interpolants;
+	/// Shared nodes and weights.
+	TB_BriTable myTable;
+	/// Explicit nodes evenly spaced (specialized kernels apply).
+	bool        myUniform;
+	float       myOrigin;
+	float       myStep;
+	/// SoA channels of all samples (owned).
+	float      *myData;
+	/// Channels blended: myData or a mapped cache, channel c of 
+	/// sample g at myBlocks + (g*myChannels + c)*myStride.
+	const float *myBlocks;
+	int64        myStride;
 };
 
 
@@ -211,34 +353,51 @@ public:
 	/// This requires initialization.
 	SplineInterpolant()
 	{
+		myEntries          = 0;
 		valid              = false;
 		alloc              = false;
 	};
+	
+	~SplineInterpolant()
+	{
+		for (size_t i = 0; i < interpolants.size(); i++)
+			delete interpolants[i];
+	};
 
 	/// Allocate memory, set flags.
 	int initialize(int size, int type)
 	{
-		interpolants.resize(size);
+		interpolants.resize(size, NULL);
 		itype              = type;
 		mySize             = size;
+		myEntries          = 0;
 		valid              = false;
 		alloc              = true;
 		return               1;
 	};
 	            
-    void build(UT_PtrArray<GU_Detail*> gdps, int current_frame);
-    void build(UT_PtrArray<TB_PointMatch *>, const GU_Detail *);
+    void build(const TB_SampleSource &source);
 	void interpolate(const float, GU_Detail * const) const;
+	/// UT_Spline has no derivatives, central differences are used.
+	void differentiate(const float u, const float scale, 
+	                   GU_Detail * const gdp, const char *name = "v") const;
 
 	int getitype() const { return itype; };
 	bool isValid() const { return valid; };
 	bool isAlloc() const { return alloc; };
 	
 	
-	int getMemoryUsage() const 
+	/// Estimate: UT_Spline keeps its keys as floats, one per 
+	/// channel and sample, besides the object itself.
+	int64 getMemoryUsage() const 
 	{ 
-	    // No idea...
-	    int mem = 0;
+	    int64 mem = (int64)interpolants.capacity() * sizeof(UT_Spline *);
+	    for (size_t i = 0; i < interpolants.size(); i++)
+	    {
+	        if (!interpolants[i]) continue;
+	        mem += sizeof(UT_Spline) 
+	             + (int64)myEntries * myLayout.getNumChannels() * sizeof(float);
+	    }
 	    return mem;
 	};
 	
@@ -255,6 +414,7 @@ private:
 	}
 	
 	int  mySize;  
+	int  myEntries;
 	bool valid;
 	int  itype;
 	bool alloc;
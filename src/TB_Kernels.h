@@ -0,0 +1,257 @@
+#ifndef __TB_Kernels_h__
+#define __TB_Kernels_h__
+
+#include <SYS/SYS_Types.h>
+#include <SYS/SYS_Math.h>
+
+/// Compile-time specialized coefficient kernels. Samples are practically
+/// always a handful of equispaced nodes, so Floater-Hormann weights of
+/// (sample count, order) are known at compile time, and loops of known
+/// trip count are unrolled by the compiler. Weights of equispaced nodes
+/// don't depend on spacing (up to a common factor, which cancels in
+/// normalization): w[k] = (-1)^k * sum(C(d, k-i)), i in J_k.
+
+namespace TimeBlender
+{
+/// Kernels are instantiated for sample counts up to this one.
+#define TB_KERNEL_MAX_ENTRIES 9
+
+/// C(N, K).
+template <int N, int K> struct TB_Binomial
+{
+    enum { value = TB_Binomial<N-1, K-1>::value + TB_Binomial<N-1, K>::value };
+};
+template <int N> struct TB_Binomial<N, 0> { enum { value = 1 }; };
+template <int N> struct TB_Binomial<N, N> { enum { value = 1 }; };
+template <> struct TB_Binomial<0, 0> { enum { value = 1 }; };
+
+/// sum(C(D, K-i)) for i in [I, IMAX].
+template <int D, int K, int I, int IMAX> struct TB_WeightSum
+{
+    enum { value = TB_Binomial<D, K-I>::value + TB_WeightSum<D, K, I+1, IMAX>::value };
+};
+template <int D, int K, int IMAX> struct TB_WeightSum<D, K, IMAX, IMAX>
+{
+    enum { value = TB_Binomial<D, K-IMAX>::value };
+};
+
+/// Weight of node K out of N equispaced ones, order D.
+template <int N, int D, int K> struct TB_EquiWeight
+{
+    enum { imin  = K-D > 0 ? K-D : 0,
+           imax  = K < N-1-D ? K : N-1-D,
+           value = (K & 1 ? -1 : 1) * TB_WeightSum<D, K, imin, imax>::value };
+};
+
+/// Fills w[K..N) with weights of (N, D).
+template <int N, int D, int K> struct TB_FillWeights
+{
+    static inline void fill(float *w)
+    {
+        w[K] = (float)TB_EquiWeight<N, D, K>::value;
+        TB_FillWeights<N, D, K+1>::fill(w);
+    }
+};
+template <int N, int D> struct TB_FillWeights<N, D, N>
+{
+    static inline void fill(float *) {}
+};
+
+/// Barycentric rational coefficients of N equispaced nodes
+/// (origin + k*step) of order D. lambda[k] = w[k]/(u-x[k]) normalized,
+/// multiplied through by prod(u-x[j]), so there's no division by zero,
+/// and no branch on hitting a node exactly.
+template <int N, int D> struct TB_BriKernel
+{
+    static inline void coefficients(float u, float origin, float step, float *lambda)
+    {
+        float w[N], t[N], suffix[N];
+        TB_FillWeights<N, D, 0>::fill(w);
+        for (int k = 0; k < N; k++)
+            t[k] = u - (origin + k*step);
+
+        suffix[N-1] = 1.0f;
+        for (int k = N-1; k > 0; k--)
+            suffix[k-1] = suffix[k] * t[k];
+
+        float prefix = 1.0f, q = 0.0f;
+        for (int k = 0; k < N; k++)
+        {
+            lambda[k] = w[k] * prefix * suffix[k];
+            q        += lambda[k];
+            prefix   *= t[k];
+        }
+
+        q = 1.0f / q;
+        for (int k = 0; k < N; k++)
+            lambda[k] *= q;
+    }
+};
+
+/// Runtime selection of TB_BriKernel<N, D>, D counting down to 0.
+template <int N, int D> struct TB_BriOrderSwitch
+{
+    static inline bool run(int d, float u, float origin, float step, float *lambda)
+    {
+        if (d != D)
+            return TB_BriOrderSwitch<N, D-1>::run(d, u, origin, step, lambda);
+        TB_BriKernel<N, D>::coefficients(u, origin, step, lambda);
+        return true;
+    }
+};
+template <int N> struct TB_BriOrderSwitch<N, -1>
+{
+    static inline bool run(int, float, float, float, float *) { return false; }
+};
+
+/// ... and of N, counting down to 2.
+template <int N> struct TB_BriSizeSwitch
+{
+    static inline bool run(int n, int d, float u, float origin, float step, float *lambda)
+    {
+        if (n != N)
+            return TB_BriSizeSwitch<N-1>::run(n, d, u, origin, step, lambda);
+        return TB_BriOrderSwitch<N, N-1>::run(d, u, origin, step, lambda);
+    }
+};
+template <> struct TB_BriSizeSwitch<1>
+{
+    static inline bool run(int, int, float, float, float, float *) { return false; }
+};
+
+/// Coefficients of n equispaced nodes of order d with a specialized
+/// kernel. Returns false for n > TB_KERNEL_MAX_ENTRIES (or d >= n),
+/// which are left to the generic TB_BriTable.
+inline bool
+TBbriCoefficients(int n, int d, float u, float origin, float step, float *lambda)
+{
+    return TB_BriSizeSwitch<TB_KERNEL_MAX_ENTRIES>::run(n, d, u, origin, step, lambda);
+}
+
+/// Maps time u onto uniform 0-1 parameter of n ascending nodes, 
+/// linearly within each interval, clamped to nodes' range. Lets 
+/// uniform bases run over arbitrarily spaced samples. slope (if given)
+/// gets the derivative of the mapping, 0 where it's clamped.
+inline float
+TBnodeParameter(const float *nodes, int n, float u, float *slope = NULL)
+{
+    if (slope) *slope = 0.0f;
+    if (n < 2 || u < nodes[0]) return 0.0f;
+    if (u > nodes[n-1])        return 1.0f;
+    int lo = 0, hi = n-1;
+    while (hi - lo > 1)
+    {
+        int mid = (lo + hi) / 2;
+        if (nodes[mid] <= u) lo = mid;
+        else                 hi = mid;
+    }
+    float t = (u - nodes[lo]) / (nodes[hi] - nodes[lo]);
+    if (slope) *slope = 1.0f / ((n-1) * (nodes[hi] - nodes[lo]));
+    return (lo + t) / (n-1);
+}
+
+/// Spline bases as coefficient vectors over n uniform samples spanning
+/// 0-1: lambda[0..count) weights samples first..first+count. u is clamped
+/// to 0-1. Returns count.
+inline int
+TBlinearCoefficients(int n, float u, float *lambda, int &first)
+{
+    first = 0;
+    if (n < 2)
+    {
+        lambda[0] = 1.0f;
+        return 1;
+    }
+    float x = SYSclamp(u, 0.0f, 1.0f) * (n-1);
+    int   s = SYSmin((int)x, n-2);
+    float t = x - s;
+    first     = s;
+    lambda[0] = 1.0f - t;
+    lambda[1] = t;
+    return 2;
+}
+
+/// Uniform Catmull-Rom, end samples are repeated (their coefficients
+/// folded into the window), so the curve passes through all samples.
+inline int
+TBcatmullRomCoefficients(int n, float u, float *lambda, int &first)
+{
+    if (n < 3)
+        return TBlinearCoefficients(n, u, lambda, first);
+
+    float x  = SYSclamp(u, 0.0f, 1.0f) * (n-1);
+    int   s  = SYSmin((int)x, n-2);
+    float t  = x - s;
+    float t2 = t*t, t3 = t2*t;
+    float b[4];
+    b[0] = 0.5f * (-t3 + 2.0f*t2 - t);
+    b[1] = 0.5f * (3.0f*t3 - 5.0f*t2 + 2.0f);
+    b[2] = 0.5f * (-3.0f*t3 + 4.0f*t2 + t);
+    b[3] = 0.5f * (t3 - t2);
+
+    first     = SYSmax(s-1, 0);
+    int last  = SYSmin(s+2, n-1);
+    int count = last - first + 1;
+    for (int k = 0; k < count; k++)
+        lambda[k] = 0.0f;
+    for (int k = 0; k < 4; k++)
+    {
+        int g = SYSclamp(s-1+k, 0, n-1);
+        lambda[g - first] += b[k];
+    }
+    return count;
+}
+
+/// Derivatives (d/du) of TBlinearCoefficients(), same window, 
+/// zero where u is clamped.
+inline int
+TBlinearDerivatives(int n, float u, float *dlambda, int &first)
+{
+    first = 0;
+    if (n < 2)
+    {
+        dlambda[0] = 0.0f;
+        return 1;
+    }
+    float x = SYSclamp(u, 0.0f, 1.0f) * (n-1);
+    float d = (u < 0.0f || u > 1.0f) ? 0.0f : n-1;
+    first      = SYSmin((int)x, n-2);
+    dlambda[0] = -d;
+    dlambda[1] = d;
+    return 2;
+}
+
+/// Derivatives (d/du) of TBcatmullRomCoefficients(), same window, 
+/// zero where u is clamped.
+inline int
+TBcatmullRomDerivatives(int n, float u, float *dlambda, int &first)
+{
+    if (n < 3)
+        return TBlinearDerivatives(n, u, dlambda, first);
+
+    float x  = SYSclamp(u, 0.0f, 1.0f) * (n-1);
+    float d  = (u < 0.0f || u > 1.0f) ? 0.0f : 0.5f * (n-1);
+    int   s  = SYSmin((int)x, n-2);
+    float t  = x - s;
+    float t2 = t*t;
+    float b[4];
+    b[0] = d * (-3.0f*t2 + 4.0f*t - 1.0f);
+    b[1] = d * (9.0f*t2 - 10.0f*t);
+    b[2] = d * (-9.0f*t2 + 8.0f*t + 1.0f);
+    b[3] = d * (3.0f*t2 - 2.0f*t);
+
+    first     = SYSmax(s-1, 0);
+    int last  = SYSmin(s+2, n-1);
+    int count = last - first + 1;
+    for (int k = 0; k < count; k++)
+        dlambda[k] = 0.0f;
+    for (int k = 0; k < 4; k++)
+    {
+        int g = SYSclamp(s-1+k, 0, n-1);
+        dlambda[g - first] += b[k];
+    }
+    return count;
+}
+
+} // End of Timeblender namespace
+#endif
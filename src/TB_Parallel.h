@@ -0,0 +1,31 @@
+#ifndef __TB_Parallel_h__
+#define __TB_Parallel_h__
+
+#include <UT/UT_ThreadedAlgorithm.h>
+#include <UT/UT_Lock.h>
+#include <SYS/SYS_Types.h>
+
+/// Thin layer over HDK's UT_ThreadedAlgorithm. Work is described as 
+/// a [0, n) domain, split into contiguous ranges, one per job. Since 
+/// every index is processed by exactly the same code no matter which 
+/// job it lands in, results don't depend on the number of threads.
+
+namespace TimeBlender
+{
+/// Work executed over a range of indices [start, end).
+class TB_RangeTask
+{
+public:
+    virtual ~TB_RangeTask() {};
+    virtual void run(int start, int end) = 0;
+};
+
+/// Run task over [0, n) on up to nthreads workers (<= 0: all processors).
+/// Domains smaller than grain are processed in the calling thread.
+void TBparallelFor(int n, int nthreads, TB_RangeTask &task, int grain = 1024);
+
+/// Number of workers nthreads will actually resolve to.
+int  TBgetNumThreads(int nthreads);
+
+} // End of Timeblender namespace
+#endif
@@ -1,11 +1,11 @@
 #ifndef __TB_PointMatch_h__
 #define __TB_PointMatch_h__
 
-#include <map>
 #include <GU/GU_Detail.h>
 #include <UT/UT_SplayTree.h>
 #include <GEO/GEO_Point.h>
 #include <UT/UT_Vector3.h>
+#include <SYS/SYS_Types.h>
 
 /// This is a basic infrastructure for finding correspondence between geometries. 
 /// At first we'd like to match points via points' ids, but I'm thinking also 
@@ -36,8 +36,61 @@ typedef enum {
     CORR_TEATRA_MATCH,
 } TB_CORR_TYPES;
 
-/// Node typedef for STL map (red/black tree):
-typedef std::map<int, GEO_Point*> Tree;
+/// Returned for ids not present in a geometry.
+#define TB_MISSING_ID -1
+
+/// Flat id -> point index accelerator. Compact id ranges are stored in 
+/// a dense direct-mapped table, sparse ones in an open-addressing hash 
+/// table. Lookups return a point index or TB_MISSING_ID, never a 
+/// dangling point. If an id repeats, the lowest point index wins.
+class TB_IdIndex
+{
+public:
+    TB_IdIndex();
+    ~TB_IdIndex() { clear(); }
+    
+    /// Build from n ids, ids[i] resolves to index i.
+    int build(const int *ids, int n, int nthreads = 0);
+    
+    /// Point index of an id or TB_MISSING_ID.
+    inline int find(int id) const
+    {
+        if (myDense)
+        {
+            int64 k = (int64)id - myMin;
+            if (k < 0 || k >= myCapacity) return TB_MISSING_ID;
+            return myValues[k];
+        }
+        if (!myCapacity) return TB_MISSING_ID;
+        uint32 mask = (uint32)myCapacity - 1;
+        for (uint32 k = hash(id) & mask; ; k = (k + 1) & mask)
+        {
+            if (myValues[k] == TB_MISSING_ID) return TB_MISSING_ID;
+            if (myKeys[k] == id)              return myValues[k];
+        }
+    }
+    
+    /// Batched find: remap[i] = find(ids[i]), executed in parallel.
+    void resolve(const int *ids, int n, int *remap, int nthreads = 0) const;
+    
+    int   entries()  const { return mySize; }
+    bool  isDense()  const { return myDense; }
+    int64 getMemoryUsage() const 
+    { 
+        return myCapacity * sizeof(int) * (myDense ? 1 : 2); 
+    }
+    
+private:
+    void clear();
+    static inline uint32 hash(int id) { return (uint32)id * 2654435761u; }
+    
+    int    mySize;
+    bool   myDense;
+    int    myMin;
+    int64  myCapacity;
+    int   *myKeys;
+    int   *myValues;
+};
 
 /// TODO: This should be plain structre?
 class TB_SplayNode 
@@ -60,36 +113,53 @@ class TB_PointMatch
 {
 public:
     /// Requires initialization:
-    TB_PointMatch() {};
+    TB_PointMatch() : alloc(false), ids(NULL), detail(NULL) {};
     
-    /// Deallocate splay tree on exit:
-    ~TB_PointMatch() { delete tree;}
+    /// Deallocate ids on exit:
+    ~TB_PointMatch() { delete [] ids; }
     
     /// Alloc wiht parameters:
-    TB_PointMatch(GU_Detail * gdp, int correspond)
+    TB_PointMatch(GU_Detail * gdp, int correspond, int nthreads = 0)
+        : alloc(false), ids(NULL), detail(NULL)
     {
-        if (!initialize(gdp, correspond)) alloc = false;
+        if (!initialize(gdp, correspond, nthreads)) alloc = false;
     }
-    /// Initilialize splay tree:
-    int initialize(GU_Detail *, int correspond);
+    /// Initilialize id index:
+    int initialize(GU_Detail *, int correspond, int nthreads = 0);
     
     /// Find corresponding point based on provided ID,
-    /// and assing finding to GEO_Point *.
-    GEO_Point * find(int d);
+    /// NULL if there is no such point.
+    GEO_Point * find(int d) const;
+    
+    /// Point index of an id or TB_MISSING_ID.
+    int findIndex(int d) const { return alloc ? index.find(d) : TB_MISSING_ID; }
     
-    /// Get to the raw tree.
-    Tree * getTree() {return  tree;}
+    /// Resolve all points of other in this geometry: remap[i] is an index
+    /// of other's i-th point here, or TB_MISSING_ID. Returns missing count.
+    int resolve(const TB_PointMatch &other, int *remap, int nthreads = 0) const;
     
-    /// Tree entries == npoints.
-    int entries() const {return (int)tree->size();}
+    /// Point ids in point order.
+    const int * getIds() const {return ids;}
+    
+    /// Get to the raw index.
+    const TB_IdIndex & getIndex() const {return index;}
+    
+    GU_Detail * getDetail() const {return detail;}
+    
+    /// Index entries == npoints.
+    int entries() const {return index.entries();}
     
     /// Are we ready for searach.
-    bool isAlloc() {return alloc;}
+    bool isAlloc() const {return alloc;}
+    
+    /// Read 'id' attribute of all points of gdp into ids (in parallel).
+    static int gatherIds(const GU_Detail *gdp, int *ids, int nthreads = 0);
  
 private:
-    bool  alloc;
-          Tree      * tree;
-    const GU_Detail * detail;
+    bool        alloc;
+    int        *ids;
+    TB_IdIndex  index;
+    GU_Detail  *detail;
 };
 } // End of Timeblender namespace
 #endif
@@ -0,0 +1,82 @@
+#ifndef __TB_SampleCache_h__
+#define __TB_SampleCache_h__
+
+#include <map>
+#include <string>
+#include <UT/UT_Lock.h>
+#include <SYS/SYS_Types.h>
+
+#include "TB_SampleData.h"
+
+/// Process-wide cache of TB_SampleData shared by all procedural instances
+/// (bounds pass, instanced copies, overlapping sample windows of 
+/// consecutive frames in IPR). Entries are keyed by path, modification 
+/// time, size and the set of extracted channels, so a rewritten file 
+/// is never served stale. Unused 
+/// entries are evicted least-recently-used first once resident bytes 
+/// exceed the budget; entries still held by a procedural are never evicted.
+
+namespace TimeBlender
+{
+class TB_SampleCache
+{
+public:
+    TB_SampleCache();
+    ~TB_SampleCache();
+    
+    /// The shared instance.
+    static TB_SampleCache & getInstance();
+    
+    /// Get sample data of a file with attributes named in attribs, loading 
+    /// it on a miss (unless load is false). NULL if the file can't be read.
+    /// Must be released.
+    const TB_SampleData * acquire(const char *filename, bool wantids, 
+                                  const char *attribs = "", bool load = true);
+    
+    /// Hand over data extracted elsewhere (ie. from a full detail). 
+    /// Returns the cached data, acquired, which may differ from data
+    /// when another thread got there first (data is deleted then).
+    const TB_SampleData * insert(const char *filename, bool wantids, 
+                                 const char *attribs, TB_SampleData *data);
+    
+    /// Drop a reference obtained with acquire() or insert().
+    void release(const TB_SampleData *data);
+    
+    /// Byte cap of unreferenced entries.
+    void  setMaxBytes(int64 bytes);
+    int64 getMaxBytes() const { return myMaxBytes; }
+    
+    /// Stats:
+    int64 getHits()          const { return myHits; }
+    int64 getMisses()        const { return myMisses; }
+    int64 getResidentBytes() const { return myResidentBytes; }
+    int   entries()          const { return (int)myEntries.size(); }
+    
+private:
+    struct Entry
+    {
+        TB_SampleData *data;
+        int            refs;
+        int64          tick;
+        int64          bytes;
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+    
+    /// Key of a file, false if it can't be stat'ed.
+    static bool makeKey(const char *filename, bool wantids, 
+                        const char *attribs, std::string &key);
+    /// Find an entry and acquire it, must be called locked.
+    const TB_SampleData * lookup(const std::string &key);
+    /// Evict unreferenced entries over budget, must be called locked.
+    void evict();
+    
+    EntryMap  myEntries;
+    int64     myMaxBytes;
+    int64     myResidentBytes;
+    int64     myTick;
+    int64     myHits;
+    int64     myMisses;
+    UT_Lock   myLock;
+};
+} // End of Timeblender namespace
+#endif
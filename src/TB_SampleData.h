@@ -0,0 +1,211 @@
+#ifndef __TB_SampleData_h__
+#define __TB_SampleData_h__
+
+#include <string>
+#include <vector>
+#include <GU/GU_Detail.h>
+#include <GEO/GEO_Point.h>
+#include <UT/UT_BoundingBox.h>
+#include <UT/UT_PtrArray.h>
+#include <UT/UT_WorkArgs.h>
+#include <SYS/SYS_Types.h>
+
+#include "TB_PointMatch.h"
+
+/// Interpolants only ever read positions, selected float attributes 
+/// (and ids for matching) from samples other than the reference frame, 
+/// so instead of keeping whole details around, samples are reduced to 
+/// compact channel arrays right after load. Only the reference frame 
+/// keeps its topology.
+
+namespace TimeBlender
+{
+/// Float tuple point attribute carried along with P.
+struct TB_ChannelAttrib
+{
+    std::string name;
+    int         size;
+    int         offset;
+    bool        normal;
+};
+
+/*********************************************************
+ Channels of a sample: P (channels 0-2) followed by 
+ float tuple point attributes.
+ ********************************************************/
+
+class TB_ChannelLayout
+{
+public:
+    TB_ChannelLayout() : myChannels(3) {};
+    
+    /// Keep float tuple point attributes of gdp named in 
+    /// names (space separated), in that order.
+    void build(const GU_Detail *gdp, const char *names);
+    
+    /// Append an attribute of size channels (ie. read from a baked cache).
+    void append(const char *name, int size, bool normal);
+    
+    /// Total number of float channels, P included.
+    int getNumChannels() const { return myChannels; }
+    
+    /// Attributes other than P.
+    int entries() const { return (int)myAttribs.size(); }
+    const TB_ChannelAttrib & operator()(int i) const { return myAttribs[i]; }
+    
+    /// Attribute index of a name or -1.
+    int find(const char *name) const;
+    
+private:
+    std::vector<TB_ChannelAttrib> myAttribs;
+    int                           myChannels;
+};
+
+/*********************************************************
+ Channels (structure-of-arrays) and optional ids of a 
+ single time sample.
+ ********************************************************/
+
+class TB_SampleData
+{
+public:
+    TB_SampleData();
+    ~TB_SampleData() { clear(); }
+    
+    /// Load a file into a scratch detail and keep 'P', attributes
+    /// named in attribs (and 'id') only.
+    int load(const char *filename, bool wantids, const char *attribs = "");
+    
+    /// Extract from an already loaded detail.
+    int extract(const GU_Detail *gdp, bool wantids, 
+                const char *attribs = "", int nthreads = 0);
+    
+    /// Build from raw positions p[3*n] (SoA: all x, all y, all z) and
+    /// optional ids[n], ie. for synthetic or baked data. P only. Without
+    /// index, ids can't be resolved until buildIndex().
+    int build(int n, const float *p, const int *ids, int nthreads = 0,
+              bool index = true);
+    
+    /// (Re)build the id index, nothing without ids.
+    void buildIndex(int nthreads = 0);
+    
+    /// Read point bounds of a file from its sidecar "<filename>.bounds" 
+    /// (whitespace separated: xmin ymin zmin xmax ymax zmax, then size
+    /// and mtime in ns of the file they were taken from). Fails if there
+    /// is no sidecar or it doesn't match the file's size and mtime.
+    static int readBoundsFile(const char *filename, UT_BoundingBox &box);
+    /// Write that sidecar, so later renders skip scanning the file. Fails 
+    /// quietly where it can't be written (ie. read-only caches).
+    static int writeBoundsFile(const char *filename, const UT_BoundingBox &box);
+    
+    /// Number of points.
+    int entries() const { return mySize; }
+    
+    /// Position channel of an axis (0, 1, 2).
+    const float * getP(int axis) const { return getChannel(axis); }
+    
+    /// Any channel, see TB_ChannelLayout.
+    const float * getChannel(int c) const { return myData + (int64)c * mySize; }
+    const TB_ChannelLayout & getLayout() const { return myLayout; }
+    
+    /// Point ids and their index, if loaded with ids.
+    bool         hasIds()   const { return myIds != NULL; }
+    const int  * getIds()   const { return myIds; }
+    const TB_IdIndex & getIndex() const { return myIndex; }
+    
+    /// Point bounds.
+    const UT_BoundingBox & getBounds() const { return myBox; }
+    
+    int64 getMemoryUsage() const 
+    {
+        return (int64)mySize * (sizeof(float) * myLayout.getNumChannels() 
+                                + (myIds ? sizeof(int) : 0))
+               + myIndex.getMemoryUsage();
+    }
+    
+private:
+    void clear();
+    
+    int              mySize;
+    TB_ChannelLayout myLayout;
+    float           *myData;
+    int             *myIds;
+    TB_IdIndex      myIndex;
+    UT_BoundingBox  myBox;
+};
+
+/*********************************************************
+ Resolves channels of reference points in every sample,
+ by point number or through id remap arrays. Points (or
+ attributes) missing in a sample fall back to the reference.
+ The id remap is shared by all channels. A subset of 
+ reference points can be given, which then become points
+ 0..nsubset of the source (only they are resolved).
+ ********************************************************/
+
+class TB_SampleSource
+{
+public:
+    TB_SampleSource(const UT_PtrArray<const TB_SampleData*> &samples, 
+                    int current_frame, bool matchbyid, int nthreads = 0,
+                    const int *subset = NULL, int nsubset = 0);
+    ~TB_SampleSource();
+    
+    /// Channel c (in reference layout) of ref's i-th point in sample g.
+    inline float get(int g, int c, int i) const
+    {
+        const TB_SampleData *s = mySamples(g);
+        int ri  = mySubset ? mySubset[i] : i;
+        int idx = myRemap ? myRemap[g][i] : (ri < s->entries() ? ri : TB_MISSING_ID);
+        int sc  = myChannelMap[g][c];
+        if (idx == TB_MISSING_ID || sc < 0)
+        {
+            s   = myRef;
+            idx = ri;
+            sc  = c;
+        }
+        return s->getChannel(sc)[idx];
+    }
+    
+    /// Number of samples.
+    int entries() const { return mySamples.entries(); }
+    /// Channels of the reference.
+    const TB_ChannelLayout & getLayout() const { return myRef->getLayout(); }
+    /// The reference sample.
+    const TB_SampleData * getReference() const { return myRef; }
+    /// Reference point of point i (of the subset).
+    int getRefPoint(int i) const { return mySubset ? mySubset[i] : i; }
+    /// Number of reference points (of the subset).
+    int getNumPoints() const { return myNumPoints; }
+    /// Number of (sample, point) pairs filled from the reference.
+    int getMissing() const { return myMissing; }
+    /// Bytes of id remap arrays.
+    int64 getMemoryUsage() const 
+    { 
+        return myRemap ? (int64)entries() * myNumPoints * sizeof(int) : 0; 
+    }
+    
+private:
+    const UT_PtrArray<const TB_SampleData*> &mySamples;
+    const TB_SampleData               *myRef;
+    const int                         *mySubset;
+    int                                myNumPoints;
+    int                              **myRemap;
+    int                              **myChannelMap;
+    int                                myMissing;
+};
+
+/// Loads files concurrently. Files with a preallocated detail in gdps 
+/// are loaded fully into it, other entries of gdps must be NULL. If 
+/// samples are given, samples(i) gets compact data of each file 
+/// (extracted from the full detail where there is one), or NULL if the 
+/// file can't be read. Samples come from TB_SampleCache and have to be 
+/// released there. attribs names point attributes to keep next to P.
+/// Returns number of files loaded.
+int TBloadSamples(const UT_WorkArgs &files, 
+                  UT_PtrArray<GU_Detail*> &gdps, 
+                  UT_PtrArray<const TB_SampleData*> *samples,
+                  bool wantids, const char *attribs = "", int nthreads = 0);
+
+} // End of Timeblender namespace
+#endif
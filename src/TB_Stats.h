@@ -0,0 +1,88 @@
+#ifndef __TB_Stats_h__
+#define __TB_Stats_h__
+
+#include <SYS/SYS_Types.h>
+#include <string>
+
+/// Per-procedural timing and memory counters. Phases are timed with 
+/// a monotonic wall clock, a few calls per phase per procedural, and 
+/// do nothing at all when disabled. Stats are emitted once, as a single 
+/// log line and/or a JSON line appended to a stats file.
+
+namespace TimeBlender
+{
+class TB_Stats
+{
+public:
+    typedef enum {
+        TB_STATS_BOUNDS,
+        TB_STATS_LOAD,
+        TB_STATS_MATCH,
+        TB_STATS_BUILD,
+        TB_STATS_INTERPOLATE,
+        TB_STATS_HANDOFF,
+        TB_STATS_PARTITION,
+        TB_STATS_NPHASES,
+    } TB_STATS_PHASE;
+    
+    TB_Stats();
+    
+    /// verbosity 0: no log line, 1: log line, 2: log line with cache 
+    /// stats. Non empty statsfile gets JSON lines regardless.
+    void enable(int verbosity, const char *statsfile);
+    bool isEnabled() const { return myEnabled; }
+    
+    /// Time phases, stop() accumulates, so a phase may run many times.
+    void start(TB_STATS_PHASE phase) 
+    { 
+        if (isEnabled()) myStart[phase] = now(); 
+    }
+    void stop(TB_STATS_PHASE phase)
+    {
+        if (!isEnabled()) return;
+        myTime[phase] += now() - myStart[phase];
+        myCalls[phase]++;
+    }
+    
+    /// Bytes held by a phase's data.
+    void addBytes(TB_STATS_PHASE phase, int64 bytes) 
+    { 
+        if (isEnabled()) myBytes[phase] += bytes; 
+    }
+    
+    /// Bytes handoff would hold with full copies of every motion 
+    /// segment, the baseline of shared topology.
+    void addFullCopyBytes(int64 bytes)
+    {
+        if (isEnabled()) myFullCopyBytes += bytes;
+    }
+    
+    /// Counters.
+    void setPoints(int64 n)  { myPoints  = n; }
+    void setMissing(int64 n) { myMissing = n; }
+    void setSamples(int files, int shutters) 
+    { 
+        myFiles = files; myShutters = shutters; 
+    }
+    
+    /// Emit stats of a procedural (label).
+    void report(const char *label) const;
+    
+private:
+    static double now();
+    
+    bool        myEnabled;
+    int         myVerbosity;
+    std::string myStatsFile;
+    double      myStart[TB_STATS_NPHASES];
+    double      myTime[TB_STATS_NPHASES];
+    int         myCalls[TB_STATS_NPHASES];
+    int64       myBytes[TB_STATS_NPHASES];
+    int64       myFullCopyBytes;
+    int64       myPoints;
+    int64       myMissing;
+    int         myFiles;
+    int         myShutters;
+};
+} // End of Timeblender namespace
+#endif
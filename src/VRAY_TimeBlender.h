@@ -15,10 +15,19 @@
 #include <UT/UT_WorkArgs.h>
 #include <UT/UT_PtrArray.h>
 #include <vector>
+#include "TB_Stats.h"
 
 namespace TimeBlender
 {
-/// VRAY_IGeometry, the main worker.
+class GeoInterpolant;
+class TB_SampleData;
+class TB_BucketShared;
+class TB_BakedCache;
+
+/// VRAY_IGeometry, the main worker. With bucketsize set, large point
+/// clouds are split into child procedurals of the same class, each 
+/// rendering a bucket of points (see TB_Buckets.h). A single .tbc file
+/// is a baked cache (see TB_BakedCache.h), blended straight from disk.
 class VRAY_TimeBlender: public VRAY_Procedural 
 {
 public:
@@ -31,7 +40,56 @@ virtual ~VRAY_TimeBlender();
     virtual void        render();
 
 private:
+	/// Child procedural rendering bucket of shared.
+	VRAY_TimeBlender(const VRAY_TimeBlender &parent, 
+	                 TB_BucketShared *shared, int bucket);
+	
 	int saveGeometry(const GU_Detail *, const UT_String *);
+	
+	/// Loaded samples (and their times) in loaded (nodes), 
+	/// returns index of the reference among them.
+	int compactSamples(const UT_PtrArray<const TB_SampleData *> &samples,
+	                   UT_PtrArray<const TB_SampleData *> &loaded,
+	                   std::vector<float> &nodes) const;
+	
+	/// Interpolant of npoints reference points (or subset of them),
+	/// samples are released to the cache.
+	GeoInterpolant * buildInterpolant(const UT_PtrArray<const TB_SampleData *> &samples,
+	                                  int npoints, const int *subset);
+	
+	/// Interpolated motion segments of ref, consumes gi and ref.
+	void addMotionSegments(GeoInterpolant *gi, GU_Detail *ref);
+	
+	/// addMotionSegments() of velocity motion modes.
+	void addVelocitySegments(GeoInterpolant *gi, GU_Detail *ref);
+	
+	/// Partitions points of ref into child procedurals, consumes ref 
+	/// and samples. Returns false (consuming nothing) if the bucket 
+	/// cache can't be written.
+	bool addBuckets(GU_Detail *ref, const UT_PtrArray<const TB_SampleData *> &samples);
+	
+	/// render() of a child procedural.
+	void renderBucket();
+	
+	/// Map the baked cache given instead of samples.
+	void openBaked();
+	
+	/// render() of a baked cache.
+	void renderBaked();
+	
+	/// Bounds padding for interpolant overshoot (fraction of extent).
+	float getPadding() const;
+	
+	/// Bounds of samples, padded for interpolant overshoot.
+	void computeBounds();
+	
+	/// Keep only samples covering the shutter (plus stencil margin) 
+	/// when sample_times are given.
+	void selectSamples(const UT_String &times);
+	
+	/// Interpolation time of i-th shutter sample, 
+	/// shutter is set to its normalized (0-1) offset.
+	fpreal getShutterTime(int i, fpreal &shutter) const;
 
     UT_BoundingBox  myBox;
     fpreal          myshutter;
@@ -42,8 +100,27 @@ private:
     int             mycurrentframe;
     int             mymatchbyid;
     int             myfiles;
+    int             mythreads;
+    int             myboundsmode;
+    int             mywritebounds;
+    int             mysharetopology;
+    int             mystencil;
+    int             myorder;
+    int             mybucketsize;
+    int             myverbose;
+    int             mymotionmode;
+    fpreal          myfps;
+    TB_BucketShared *myshared;
+    int             mybucket;
+    TB_BakedCache  *mybaked;
+    /// Explicit times of (selected) files, empty without sample_times.
+    std::vector<float> mytimes;
     UT_String       shop_materialpath;
     UT_String       myfilenamestring;
+    UT_String       myattributes;
+    UT_String       mystatsfile;
+    UT_String       mybucketdir;
+    TB_Stats        mystats;
     UT_WorkArgs     myfilenamelist;
 };
 }//End of timeblender namescape